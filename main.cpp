@@ -2,12 +2,30 @@
 #include <iostream>
 #include <filesystem>
 #include <sstream>
+#include <vector>
 
 #include "src/CommandHandler.h"
+#include "src/Server.h"
+#include "src/Client.h"
 
 namespace fs = std::filesystem;
 
-int main() {
+int main(int argc, char* argv[]) {
+    const std::vector<std::string> args(argv + 1, argv + argc);
+
+    if (!args.empty() && (args[0] == "--serve" || args[0] == "--client")) {
+        if (args.size() < 2) {
+            std::cerr << "Usage: " << argv[0] << " --serve SOCKET" << std::endl;
+            std::cerr << "       " << argv[0] << " --client SOCKET [COMMAND...]" << std::endl;
+            return 1;
+        }
+        if (args[0] == "--serve") {
+            Server server(args[1]);
+            return server.run();
+        }
+        return Client::run(args[1], {args.begin() + 2, args.end()});
+    }
+
     std::cout << "Welcome to FileManager!" << std::endl;
     std::cout << "To leave enter \"exit\"" << std::endl;
 
@@ -15,7 +33,7 @@ int main() {
     CommandHandler commandHandler;
 
     while (true) {
-        std::cout << fs::current_path().filename() << "> ";
+        std::cout << commandHandler.currentDirectory().filename() << "> ";
         std::getline(std::cin, input);
 
         if (input == "exit") {
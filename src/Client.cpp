@@ -0,0 +1,135 @@
+#include <iostream>
+#include <cerrno>
+#include <cstring>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "Client.h"
+#include "Server.h"
+
+int Client::run(const std::string& socketPath, const std::vector<std::string>& command) {
+    // The server reads one command per line, so a line break inside an
+    // argument would smuggle in a second command.
+    for (const auto& argument : command) {
+        if (argument.find_first_of("\r\n") != std::string::npos) {
+            std::cerr << "Error: command arguments must not contain line breaks" << std::endl;
+            return 1;
+        }
+        // The server's tokenizer drops empty tokens and has no escapes, so an
+        // argument that is empty or holds both quote characters cannot be sent.
+        if (argument.empty()) {
+            std::cerr << "Error: command arguments must not be empty" << std::endl;
+            return 1;
+        }
+        if (argument.find('"') != std::string::npos && argument.find('\'') != std::string::npos) {
+            std::cerr << "Error: command arguments must not contain both ' and \"" << std::endl;
+            return 1;
+        }
+    }
+
+    int fd = connectTo(socketPath);
+    if (fd < 0) return 1;
+
+    bool ok = true;
+    if (!command.empty()) {
+        std::string line;
+        for (const auto& argument : command) {
+            if (!line.empty()) line += ' ';
+            line += quote(argument);
+        }
+        ok = execute(fd, line);
+    } else {
+        bool interactive = isatty(STDIN_FILENO);
+        std::string input;
+
+        while (true) {
+            if (interactive) std::cout << "> " << std::flush;
+            if (!std::getline(std::cin, input) || input == "exit") break;
+            if (input.empty()) continue;
+
+            if (!execute(fd, input)) {
+                ok = false;
+                break;
+            }
+            if (interactive) std::cout << std::endl;
+        }
+    }
+
+    close(fd);
+    return ok ? 0 : 1;
+}
+
+int Client::connectTo(const std::string& socketPath) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        std::cerr << "Error: socket path too long: " << socketPath << std::endl;
+        return -1;
+    }
+    std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        std::cerr << "Error: cannot connect to " << socketPath << ": " << std::strerror(errno) << std::endl;
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool Client::execute(int fd, const std::string& line) {
+    std::string request = line + "\n";
+    for (std::size_t sent = 0; sent < request.size();) {
+        ssize_t written = send(fd, request.data() + sent, request.size() - sent, MSG_NOSIGNAL);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "Error: lost connection to server: " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        sent += static_cast<std::size_t>(written);
+    }
+
+    while (true) {
+        unsigned char header[Protocol::FrameHeaderSize];
+        if (!readExactly(fd, reinterpret_cast<char*>(header), sizeof(header))) {
+            std::cerr << "Error: lost connection to server" << std::endl;
+            return false;
+        }
+
+        std::uint32_t length = (std::uint32_t(header[1]) << 24) | (std::uint32_t(header[2]) << 16)
+                               | (std::uint32_t(header[3]) << 8) | std::uint32_t(header[4]);
+        std::string payload(length, '\0');
+        if (!readExactly(fd, payload.data(), payload.size())) {
+            std::cerr << "Error: lost connection to server" << std::endl;
+            return false;
+        }
+
+        switch (static_cast<char>(header[0])) {
+            case Protocol::FrameStdout: std::cout << payload << std::flush; break;
+            case Protocol::FrameStderr: std::cerr << payload << std::flush; break;
+            case Protocol::FrameDone: return true;
+            default: break;
+        }
+    }
+}
+
+bool Client::readExactly(int fd, char* data, std::size_t length) {
+    while (length > 0) {
+        ssize_t got = read(fd, data, length);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) return false;
+        data += got;
+        length -= static_cast<std::size_t>(got);
+    }
+    return true;
+}
+
+std::string Client::quote(const std::string& argument) {
+    bool needsQuotes = argument.find_first_of(" \t\v\f\"'") != std::string::npos;
+    if (!needsQuotes) return argument;
+
+    char quoteChar = argument.find('"') == std::string::npos ? '"' : '\'';
+    return quoteChar + argument + quoteChar;
+}
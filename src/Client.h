@@ -0,0 +1,20 @@
+#ifndef CLIENT_H
+#define CLIENT_H
+
+#include <string>
+#include <vector>
+
+// Thin client for a FileManager server. Runs `command` if given, otherwise
+// forwards lines read from stdin until "exit" or end of input.
+class Client {
+public:
+    static int run(const std::string& socketPath, const std::vector<std::string>& command);
+
+private:
+    static int connectTo(const std::string& socketPath);
+    static bool execute(int fd, const std::string& line);
+    static bool readExactly(int fd, char* data, std::size_t length);
+    static std::string quote(const std::string& argument);
+};
+
+#endif
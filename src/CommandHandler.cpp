@@ -7,13 +7,22 @@
 #include <filesystem>
 #include <fstream>
 #include <format>
+#include <ctime>
 #include <termcolor/termcolor.hpp>
 
 #include "CommandHandler.h"
+#include "TarArchive.h"
+#include "DirectoryCache.h"
 
 namespace fs = std::filesystem;
 
-CommandHandler::CommandHandler() {
+CommandHandler::CommandHandler()
+    : CommandHandler(std::make_shared<DirectoryCache>(), std::cout, std::cerr, std::cin, fs::current_path()) {}
+
+CommandHandler::CommandHandler(std::shared_ptr<DirectoryCache> cache, std::ostream& out, std::ostream& err,
+                               std::istream& in, fs::path workingDirectory)
+    : directoryCache(std::move(cache)), outStream(out), errStream(err), inStream(in),
+      workingDirectory(std::move(workingDirectory)) {
     registerCommand("pwd", [this](const ParsedCommand& cmd) { printWorkingDirectory(); });
     registerCommand("ld", [this](const ParsedCommand& cmd) { listDirectory(cmd); });
     registerCommand("cd", [this](const ParsedCommand& cmd) { changeDirectory(cmd); });
@@ -21,6 +30,16 @@ CommandHandler::CommandHandler() {
     registerCommand("rm", [this](const ParsedCommand& cmd) { remove(cmd); });
     registerCommand("help", [this](const ParsedCommand& cmd) { showHelp(cmd); });
     registerCommand("touch", [this](const ParsedCommand& cmd) { touch(cmd); });
+    registerCommand("pack", [this](const ParsedCommand& cmd) { pack(cmd); });
+    registerCommand("unpack", [this](const ParsedCommand& cmd) { unpack(cmd); });
+}
+
+const fs::path& CommandHandler::currentDirectory() const {
+    return workingDirectory;
+}
+
+fs::path CommandHandler::resolve(const std::string& path) const {
+    return workingDirectory / path;
 }
 
 void CommandHandler::registerCommand(const std::string &name, const std::function<void(const ParsedCommand &)>& handler) {
@@ -78,7 +97,7 @@ void CommandHandler::parseAndExecute(const std::string &input) {
     ParsedCommand parsed = CommandParser::parse(tokens);
 
     if (!parsed.errors.empty()) {
-        std::cerr << "Parse errors:" << std::endl;
+        errStream << "Parse errors:" << std::endl;
         for (const auto& error : parsed.errors) { printError(error); }
         return;
     }
@@ -92,21 +111,19 @@ void CommandHandler::executeParsed(const ParsedCommand& cmd) {
         try {
             it->second(cmd);
         } catch (const std::exception& e) {
-            std::cout << "Error executing command '" << cmd.command << "': " << e.what() << std::endl;
+            outStream << "Error executing command '" << cmd.command << "': " << e.what() << std::endl;
         }
     } else {
-        std::cout << "Unknown command: " << cmd.command << std::endl;
-        std::cout << "Type 'help' for available commands" << std::endl;
+        outStream << "Unknown command: " << cmd.command << std::endl;
+        outStream << "Type 'help' for available commands" << std::endl;
     }
 }
 
 void CommandHandler::printWorkingDirectory() {
-    const std::string workingDirectory = fs::current_path().string();
-    printMessage(workingDirectory);
+    printMessage(workingDirectory.string());
 }
 
-bool CommandHandler::isHidden(const auto& entry) {
-    std::string fileName = entry.path().filename();
+bool CommandHandler::isHidden(const std::string& fileName) {
     if (fileName[0] == '.') {
         return true;
     }
@@ -117,28 +134,28 @@ void CommandHandler::listDirectory(const ParsedCommand& cmd) {
     bool longFormat = cmd.flags.count("l") > 0 || cmd.flags.count("long") > 0;
     bool all = cmd.flags.count("all") > 0 || cmd.flags.count("a") > 0;
 
-    fs::directory_iterator dirIterator(fs::current_path());
+    DirectoryCache::Listing listing = directoryCache->list(workingDirectory);
 
-    for (const auto& entry : dirIterator) {
-        if (!isHidden(entry) || all) {
+    for (const auto& entry : *listing) {
+        if (!isHidden(entry.name) || all) {
             if (!longFormat) {
-            std::string message = (entry.is_directory() ? "/" : (entry.is_symlink() ? "@" : "*")) + entry.path().filename().string();
+            std::string message = (entry.directory ? "/" : (entry.symlink ? "@" : "*")) + entry.name;
             printMessage(message);
 
         } else {
-            std::string type = entry.path().extension().string();
-            std::string file = entry.path().filename().string();
+            const fs::path entryPath = workingDirectory / entry.name;
+            std::string file = entry.name;
 
             char type_char = '-';
-            if (entry.is_directory()) type_char = 'd';
-            else if (entry.is_symlink()) type_char = 'l';
+            if (entry.directory) type_char = 'd';
+            else if (entry.symlink) type_char = 'l';
 
             std::uintmax_t size = 0;
             std::string size_str = "0";
 
             try {
-                if (entry.is_regular_file() && !entry.is_symlink()) {
-                    size = fs::file_size(entry.path());
+                if (entry.regular && !entry.symlink) {
+                    size = fs::file_size(entryPath);
 
                     if (size < 1024) {
                         size_str = std::to_string(size) + " B";
@@ -156,20 +173,23 @@ void CommandHandler::listDirectory(const ParsedCommand& cmd) {
 
             std::string time_str;
             try {
-                auto ftime = fs::last_write_time(entry.path());
+                auto ftime = fs::last_write_time(entryPath);
                 auto sctp = std::chrono::time_point_cast<std::chrono::system_clock::duration>(
                     ftime - fs::file_time_type::clock::now() + std::chrono::system_clock::now()
                 );
                 std::time_t cftime = std::chrono::system_clock::to_time_t(sctp);
-                time_str = std::ctime(&cftime);
-                time_str.pop_back();
+                std::tm local{};
+                char buffer[32];
+                localtime_r(&cftime, &local);
+                std::strftime(buffer, sizeof(buffer), "%a %b %e %H:%M:%S %Y", &local);
+                time_str = buffer;
             } catch (...) {
                 time_str = "N/A";
             }
 
             std::string message = std::format("{}{} {:>10} {:>20} {}",
                 type_char,
-                (entry.is_symlink() ? "l" : (entry.is_directory() ? "d" : "-")),
+                (entry.symlink ? "l" : (entry.directory ? "d" : "-")),
                 size_str,
                 time_str,
                 file);
@@ -189,7 +209,9 @@ void CommandHandler::changeDirectory(const ParsedCommand& cmd) {
     const std::string dir = cmd.arguments[0];
 
     try {
-        std::filesystem::current_path(dir);
+        fs::path target = fs::canonical(resolve(dir));
+        if (!fs::is_directory(target)) throw std::runtime_error("not a directory");
+        workingDirectory = target;
     } catch (...) {
         std::string message = std::format("cd: cannot change directory '{}'", dir);
         printError(message);
@@ -207,16 +229,17 @@ void CommandHandler::touch(const ParsedCommand &cmd) {
     bool force = cmd.flags.count("f") > 0 || cmd.flags.count("force") > 0;
     bool interactive = cmd.flags.count("i") > 0 || cmd.flags.count("interactive") > 0;
     const std::string file = cmd.arguments[0];
+    const fs::path path = resolve(file);
     std::string message;
 
-    if (fs::exists(file)) {
+    if (fs::exists(path)) {
         if (!force) {
             message = std::format("touch: file '{}' already exists", file);
             printMessage(message);
 
             if (confirmChange(file, interactive)) {
                 removeFile(file, true, false);
-                std::ofstream outputFile(file);
+                std::ofstream outputFile(path);
                 if (verbose) {
                     message = std::format("touch: rewrote file '{}'", file);
                     printMessage(message);
@@ -226,14 +249,14 @@ void CommandHandler::touch(const ParsedCommand &cmd) {
             }
         } else {
             removeFile(file, true, false);
-            std::ofstream outputFile(file);
+            std::ofstream outputFile(path);
             if (verbose) {
                 message = std::format("touch: rewrote file '{}'", file);
                 printMessage(message);
             }
         }
     } else {
-        std::ofstream outputFile(file);
+        std::ofstream outputFile(path);
         if (verbose) {
             message = std::format("touch: rewrote file '{}'", file);
             printMessage(message);
@@ -261,7 +284,7 @@ void CommandHandler::makeDirectory(const ParsedCommand &cmd) {
         try {
             mode = std::stoi(modeIt->second, nullptr, 8);
         } catch (...) {
-            std::cerr << "Invalid mode: " << modeIt->second << std::endl;
+            errStream << "Invalid mode: " << modeIt->second << std::endl;
             return;
         }
     }
@@ -269,17 +292,17 @@ void CommandHandler::makeDirectory(const ParsedCommand &cmd) {
     for (const auto& dir : cmd.arguments) {
         try {
             if (createParents) {
-                fs::create_directories(dir);
+                fs::create_directories(resolve(dir));
                 if (verbose) {
                     message = std::format("mkdir: created directory '{}'", dir);
                     printMessage(message);
                 }
             } else {
-                if (fs::exists(dir)) {
+                if (fs::exists(resolve(dir))) {
                     message = std::format("mkdir: file '{}' already exists", dir);
                     printError(message);
                 } else {
-                    fs::create_directory(dir);
+                    fs::create_directory(resolve(dir));
                     if (verbose) {
                         message = std::format("mkdir: created directory '{}'", dir);
                         printMessage(message);
@@ -293,73 +316,146 @@ void CommandHandler::makeDirectory(const ParsedCommand &cmd) {
     }
 }
 
+void CommandHandler::pack(const ParsedCommand &cmd) {
+    if (cmd.arguments.size() < 2) {
+        printError("pack: missing archive or file operand");
+        printUsage("pack");
+        return;
+    }
+
+    bool verbose = cmd.flags.count("v") > 0 || cmd.flags.count("verbose") > 0;
+    const std::string archive = cmd.arguments[0];
+    std::vector<std::string> paths(cmd.arguments.begin() + 1, cmd.arguments.end());
+
+    try {
+        ArchiveStats stats = TarArchive::pack(resolve(archive), workingDirectory, paths,
+            [this, verbose](const std::string& name) { if (verbose) printMessage(name); },
+            [this](const std::string& warning) { printWarning(warning); });
+
+        std::string message = std::format("pack: wrote {} entries ({} bytes) to '{}'", stats.entries, stats.bytes, archive);
+        printMessage(message);
+        if (stats.skipped > 0) {
+            printWarning(std::format("pack: skipped {} entries", stats.skipped));
+        }
+    } catch (const std::exception& e) {
+        printError(e.what());
+    }
+}
+
+void CommandHandler::unpack(const ParsedCommand &cmd) {
+    if (cmd.arguments.empty()) {
+        printError("unpack: missing archive operand");
+        printUsage("unpack");
+        return;
+    }
+
+    bool verbose = cmd.flags.count("v") > 0 || cmd.flags.count("verbose") > 0;
+    const std::string archive = cmd.arguments[0];
+    const std::string destination = cmd.arguments.size() > 1 ? cmd.arguments[1] : workingDirectory.string();
+
+    try {
+        ArchiveStats stats = TarArchive::unpack(resolve(archive), resolve(destination),
+            [this, verbose](const std::string& name) { if (verbose) printMessage(name); },
+            [this](const std::string& warning) { printWarning(warning); });
+
+        std::string message = std::format("unpack: extracted {} entries ({} bytes) to '{}'", stats.entries, stats.bytes, destination);
+        printMessage(message);
+        if (stats.skipped > 0) {
+            printWarning(std::format("unpack: skipped {} entries", stats.skipped));
+        }
+    } catch (const std::exception& e) {
+        printError(e.what());
+    }
+}
+
 void CommandHandler::showHelp(const ParsedCommand& cmd) {
     if (!cmd.arguments.empty()) {
         printUsage(cmd.arguments[0]);
     } else {
-        std::cout << "\n======Available Commands======" << std::endl;
-        std::cout << "pwd                             - Print current working directory" << std::endl;
-        std::cout << "ld                              - Show all files and directories in current path" << std::endl;
-        std::cout << "cd                              - Change working directory" << std::endl;
-        std::cout << "mkdir                           - Make directory called <name>" << std::endl;
-        std::cout << "rm                              - Remove directory called <name>" << std::endl;
-        std::cout << "help                            - Show this help message" << std::endl;
-        std::cout << "Use 'help <command>' for detailed usage of a specific command" << std::endl;
+        outStream << "\n======Available Commands======" << std::endl;
+        outStream << "pwd                             - Print current working directory" << std::endl;
+        outStream << "ld                              - Show all files and directories in current path" << std::endl;
+        outStream << "cd                              - Change working directory" << std::endl;
+        outStream << "mkdir                           - Make directory called <name>" << std::endl;
+        outStream << "rm                              - Remove directory called <name>" << std::endl;
+        outStream << "pack                            - Pack files into a tar archive" << std::endl;
+        outStream << "unpack                          - Extract a tar archive into <dir>" << std::endl;
+        outStream << "help                            - Show this help message" << std::endl;
+        outStream << "Use 'help <command>' for detailed usage of a specific command" << std::endl;
     }
 }
 
 void CommandHandler::printUsage(const std::string& command) {
     if (command == "mkdir") {
-        std::cout << "\nUsage: mkdir [OPTION]... DIRECTORY..." << std::endl;
-        std::cout << "Create the DIRECTORY(ies), if they do not already exist.\n" << std::endl;
-        std::cout << "Options:" << std::endl;
-        std::cout << "  -p, --parents     no error if existing, make parent directories as needed" << std::endl;
-        std::cout << "  -m, --mode=MODE   set file mode (as in chmod), not in Windows" << std::endl;
-        std::cout << "  -v, --verbose     print a message for each created directory" << std::endl;
-        std::cout << "\nExamples:" << std::endl;
-        std::cout << "  mkdir dir1                    Create single directory" << std::endl;
-        std::cout << "  mkdir -p dir1/dir2/dir3       Create directory tree" << std::endl;
-        std::cout << "  mkdir dir1 dir2 dir3          Create multiple directories" << std::endl;
-        std::cout << "  mkdir -m 755 dir1             Create with specific permissions" << std::endl;
+        outStream << "\nUsage: mkdir [OPTION]... DIRECTORY..." << std::endl;
+        outStream << "Create the DIRECTORY(ies), if they do not already exist.\n" << std::endl;
+        outStream << "Options:" << std::endl;
+        outStream << "  -p, --parents     no error if existing, make parent directories as needed" << std::endl;
+        outStream << "  -m, --mode=MODE   set file mode (as in chmod), not in Windows" << std::endl;
+        outStream << "  -v, --verbose     print a message for each created directory" << std::endl;
+        outStream << "\nExamples:" << std::endl;
+        outStream << "  mkdir dir1                    Create single directory" << std::endl;
+        outStream << "  mkdir -p dir1/dir2/dir3       Create directory tree" << std::endl;
+        outStream << "  mkdir dir1 dir2 dir3          Create multiple directories" << std::endl;
+        outStream << "  mkdir -m 755 dir1             Create with specific permissions" << std::endl;
     } else if (command == "rm") {
-        std::cout << "\nUsage: rm [OPTION]... [FILE]..." << std::endl;
-        std::cout << "Remove (unlink) the FILE(s).\n" << std::endl;
-        std::cout << "Options:" << std::endl;
-        std::cout << "  -f, --force           ignore nonexistent files and arguments, never prompt" << std::endl;
-        std::cout << "  -i                    prompt before every removal" << std::endl;
-        std::cout << "      --interactive[=WHEN]  prompt according to WHEN: never, once (-I), or" << std::endl;
-        std::cout << "                          always (-i); without WHEN, prompt always" << std::endl;
-        std::cout << "  -r, -R, --recursive   remove directories and their contents recursively" << std::endl;
-        std::cout << "  -v, --verbose         explain what is being done" << std::endl;
-        std::cout << "      --preserve-root   do not remove '/' (default)" << std::endl;
-        std::cout << "      --no-preserve-root  do not treat '/' specially" << std::endl;
-        std::cout << "\nExamples:" << std::endl;
-        std::cout << "  rm file.txt              Remove a file" << std::endl;
-        std::cout << "  rm -i file1 file2        Remove with confirmation" << std::endl;
-        std::cout << "  rm -rf directory/        Force remove directory recursively" << std::endl;
-        std::cout << "  rm *.txt                 Remove all .txt files" << std::endl;
-        std::cout << "  rm -i *.log              Remove all .log files with confirmation" << std::endl;
-
-        std::cout << "\nImportant notes:" << std::endl;
-        std::cout << "  - By default, rm does not remove directories." << std::endl;
-        std::cout << "  - Use -r or -R to remove directories and their contents." << std::endl;
-        std::cout << "  - The -f flag overrides -i and any confirmation prompts." << std::endl;
-        std::cout << "  - Be cautious with 'rm -rf', it can cause data loss!" << std::endl;
+        outStream << "\nUsage: rm [OPTION]... [FILE]..." << std::endl;
+        outStream << "Remove (unlink) the FILE(s).\n" << std::endl;
+        outStream << "Options:" << std::endl;
+        outStream << "  -f, --force           ignore nonexistent files and arguments, never prompt" << std::endl;
+        outStream << "  -i                    prompt before every removal" << std::endl;
+        outStream << "      --interactive[=WHEN]  prompt according to WHEN: never, once (-I), or" << std::endl;
+        outStream << "                          always (-i); without WHEN, prompt always" << std::endl;
+        outStream << "  -r, -R, --recursive   remove directories and their contents recursively" << std::endl;
+        outStream << "  -v, --verbose         explain what is being done" << std::endl;
+        outStream << "      --preserve-root   do not remove '/' (default)" << std::endl;
+        outStream << "      --no-preserve-root  do not treat '/' specially" << std::endl;
+        outStream << "\nExamples:" << std::endl;
+        outStream << "  rm file.txt              Remove a file" << std::endl;
+        outStream << "  rm -i file1 file2        Remove with confirmation" << std::endl;
+        outStream << "  rm -rf directory/        Force remove directory recursively" << std::endl;
+        outStream << "  rm *.txt                 Remove all .txt files" << std::endl;
+        outStream << "  rm -i *.log              Remove all .log files with confirmation" << std::endl;
+
+        outStream << "\nImportant notes:" << std::endl;
+        outStream << "  - By default, rm does not remove directories." << std::endl;
+        outStream << "  - Use -r or -R to remove directories and their contents." << std::endl;
+        outStream << "  - The -f flag overrides -i and any confirmation prompts." << std::endl;
+        outStream << "  - Be cautious with 'rm -rf', it can cause data loss!" << std::endl;
+    } else if (command == "pack") {
+        outStream << "\nUsage: pack [OPTION]... ARCHIVE PATH..." << std::endl;
+        outStream << "Write PATH(s) and their contents to the tar ARCHIVE (POSIX ustar/pax).\n" << std::endl;
+        outStream << "Options:" << std::endl;
+        outStream << "  -v, --verbose     print the name of each archived entry" << std::endl;
+        outStream << "\nExamples:" << std::endl;
+        outStream << "  pack out.tar dir1             Archive a directory tree" << std::endl;
+        outStream << "  pack out.tar a.txt b.txt      Archive several files" << std::endl;
+    } else if (command == "unpack") {
+        outStream << "\nUsage: unpack [OPTION]... ARCHIVE [DIRECTORY]" << std::endl;
+        outStream << "Extract the tar ARCHIVE into DIRECTORY (default: current directory).\n" << std::endl;
+        outStream << "Options:" << std::endl;
+        outStream << "  -v, --verbose     print the name of each extracted entry" << std::endl;
+        outStream << "\nExamples:" << std::endl;
+        outStream << "  unpack in.tar                 Extract into current directory" << std::endl;
+        outStream << "  unpack in.tar dir1            Extract into dir1, creating it if needed" << std::endl;
+        outStream << "\nImportant notes:" << std::endl;
+        outStream << "  - A leading '/' is stripped from member names; members with '..' are skipped." << std::endl;
+        outStream << "  - Existing files with the same name are replaced." << std::endl;
     } else {
-        std::cout << "No help available for: " << command << std::endl;
+        outStream << "No help available for: " << command << std::endl;
     }
 }
 
 void CommandHandler::printError(const std::string& message) {
-    std::cerr << "Error: " << message << std::endl << std::endl;
+    errStream << "Error: " << message << std::endl << std::endl;
 }
 
 void CommandHandler::printWarning(const std::string& message) {
-    std::cerr << "Warning: " << message << std::endl;
+    errStream << "Warning: " << message << std::endl;
 }
 
 void CommandHandler::printMessage(const std::string& message) {
-    std::cout <<message << std::endl;
+    outStream <<message << std::endl;
 }
 
 void CommandHandler::remove(const ParsedCommand &cmd) {
@@ -378,8 +474,7 @@ void CommandHandler::remove(const ParsedCommand &cmd) {
     if (force) interactive = false;
     if (preserveRoot) {
         for (const auto& arg : cmd.arguments) {
-            fs::path p(arg);
-            p = fs::absolute(p);
+            fs::path p = resolve(arg).lexically_normal();
 
             if (p.root_path() == p) {
                 printError("rm: it is dangerous to operate recursively on '" + arg + "'");
@@ -393,7 +488,7 @@ void CommandHandler::remove(const ParsedCommand &cmd) {
 
     for (const auto& pathStr : cmd.arguments) {
         try {
-            fs::path path(pathStr);
+            fs::path path = resolve(pathStr);
 
             if (!fs::exists(path)) {
                 if (!force) {
@@ -405,18 +500,18 @@ void CommandHandler::remove(const ParsedCommand &cmd) {
 
             if (fs::is_directory(path)) {
                 if (recursive) {
-                    removeDirectoryRecursive(path.string(), force, interactive);
+                    removeDirectoryRecursive(pathStr, force, interactive);
                     if (verbose) {
-                        std::cout << "removed directory '" << pathStr << "'" << std::endl;
+                        outStream << "removed directory '" << pathStr << "'" << std::endl;
                     }
                 } else {
                     printError("rm: cannot remove '" + pathStr + "': Is a directory");
                     anyError = true;
                 }
             } else {
-                removeFile(path.string(), force, interactive);
+                removeFile(pathStr, force, interactive);
                 if (verbose) {
-                    std::cout << "removed file '" << pathStr << "'" << std::endl;
+                    outStream << "removed file '" << pathStr << "'" << std::endl;
                 }
             }
         } catch (const fs::filesystem_error& e) {
@@ -429,7 +524,7 @@ void CommandHandler::remove(const ParsedCommand &cmd) {
     }
 
     if (anyError && !force) {
-        std::cerr << "rm: some files could not be removed" << std::endl;
+        errStream << "rm: some files could not be removed" << std::endl;
     }
 }
 
@@ -438,9 +533,9 @@ bool CommandHandler::confirmDeletion(const std::string &path, bool interactive)
         return true;
     }
 
-    std::cout << "rm: remove '" << path << "'? [y/n] ";
+    outStream << "rm: remove '" << path << "'? [y/n] ";
     std::string response;
-    std::getline(std::cin, response);
+    std::getline(inStream, response);
 
     return !response.empty() && (response[0] == 'y' || response[0] == 'Y');
 }
@@ -450,9 +545,9 @@ bool CommandHandler::confirmChange(const std::string &file, bool interactive) {
         return true;
     }
 
-    std::cout << "touch: rewrite '" << file << "'? [y/n] ";
+    outStream << "touch: rewrite '" << file << "'? [y/n] ";
     std::string response;
-    std::getline(std::cin, response);
+    std::getline(inStream, response);
 
     return !response.empty() && (response[0] == 'y' || response[0] == 'Y');
 }
@@ -463,34 +558,36 @@ void CommandHandler::removeFile(const std::string &path, bool force, bool intera
     }
 
     try {
-        if (!fs::remove(path)) {
+        if (!fs::remove(resolve(path))) {
             if (!force) {
                 throw fs::filesystem_error("Cannot remove file", fs::path(path),std::error_code());
             }
         }
     } catch (const fs::filesystem_error& e) {
         if (!force) {
-            throw;
+            throw displayedError(e, path);
         }
     }
 }
 
 void CommandHandler::removeDirectoryRecursive(const std::string &path, bool force, bool interactive) {
-    if (fs::is_empty(path)) {
+    const fs::path target = resolve(path);
+
+    if (fs::is_empty(target)) {
         if (confirmDeletion(path, interactive)) {
             try {
-                fs::remove(path);
-            } catch (...) {
-                if (!force) throw;
+                fs::remove(target);
+            } catch (const fs::filesystem_error& e) {
+                if (!force) throw displayedError(e, path);
             }
         }
         return;
     }
 
     if (interactive) {
-        std::cout << "rm: descend into directory '" << path << "'? [y/n] ";
+        outStream << "rm: descend into directory '" << path << "'? [y/n] ";
         std::string response;
-        std::getline(std::cin, response);
+        std::getline(inStream, response);
 
         if (!(response[0] == 'y' || response[0] == 'Y') || response.empty()) {
             return;
@@ -498,8 +595,8 @@ void CommandHandler::removeDirectoryRecursive(const std::string &path, bool forc
     }
 
     try {
-        for (const auto& entry : fs::directory_iterator(path)) {
-            std::string entryPath = entry.path().string();
+        for (const auto& entry : fs::directory_iterator(target)) {
+            std::string entryPath = (fs::path(path) / entry.path().filename()).string();
 
             if (fs::is_directory(entry.status())) {
                 removeDirectoryRecursive(entryPath, force, interactive);
@@ -509,15 +606,25 @@ void CommandHandler::removeDirectoryRecursive(const std::string &path, bool forc
         }
 
         if (confirmDeletion(path, interactive)) {
-            fs::remove(path);
+            fs::remove(target);
         }
     } catch (const fs::filesystem_error& e) {
         if (!force) {
-            throw;
+            throw displayedError(e, path);
         }
 
         try {
-            fs::remove_all(path);
+            fs::remove_all(target);
         } catch (...) { }
     }
-}
\ No newline at end of file
+}
+
+fs::filesystem_error CommandHandler::displayedError(const fs::filesystem_error& e, const std::string& path) const {
+    // Errors raised on resolved paths are reported relative to what the user typed.
+    const fs::path relative = e.path1().lexically_relative(resolve(path));
+    if (e.path1().empty() || relative.empty() || *relative.begin() == "..") {
+        return e;
+    }
+    fs::path shown = relative == "." ? fs::path(path) : fs::path(path) / relative;
+    return fs::filesystem_error("cannot remove", shown, e.code());
+}
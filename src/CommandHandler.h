@@ -6,43 +6,60 @@
 #include <functional>
 #include <vector>
 #include <filesystem>
+#include <iostream>
+#include <memory>
 
 #include "CommandParser.h"
+#include "DirectoryCache.h"
 
 namespace fs = std::filesystem;
 
 class CommandHandler {
 public:
     CommandHandler();
+    CommandHandler(std::shared_ptr<DirectoryCache> cache, std::ostream& out, std::ostream& err,
+                   std::istream& in, fs::path workingDirectory);
 
     void parseAndExecute(const std::string& input);
     void executeParsed(const ParsedCommand& cmd);
 
     void registerCommand(const std::string& name, const std::function<void(const ParsedCommand&)>& handler);
 
+    const fs::path& currentDirectory() const;
+
 private:
     std::map<std::string, std::function<void(const ParsedCommand&)>> commands;
+    std::shared_ptr<DirectoryCache> directoryCache;
+    std::ostream& outStream;
+    std::ostream& errStream;
+    std::istream& inStream;
+    fs::path workingDirectory;
+
+    fs::path resolve(const std::string& path) const;
+    fs::filesystem_error displayedError(const fs::filesystem_error& e, const std::string& path) const;
 
-    static void printWorkingDirectory();
-    static void listDirectory(const ParsedCommand& cmd);
-    static void changeDirectory(const ParsedCommand& cmd);
-    static void makeDirectory(const ParsedCommand& cmd);
-    static void remove(const ParsedCommand& cmd);
-    static void showHelp(const ParsedCommand& cmd);
-    static void touch(const ParsedCommand& cmd);
+    void printWorkingDirectory();
+    void listDirectory(const ParsedCommand& cmd);
+    void changeDirectory(const ParsedCommand& cmd);
+    void makeDirectory(const ParsedCommand& cmd);
+    void remove(const ParsedCommand& cmd);
+    void showHelp(const ParsedCommand& cmd);
+    void touch(const ParsedCommand& cmd);
+    void pack(const ParsedCommand& cmd);
+    void unpack(const ParsedCommand& cmd);
 
-    static bool confirmDeletion(const std::string& path, bool interactive);
-    static bool isHidden(const auto& entry);
-    static bool confirmChange(const std::string& path, bool interactive);
-    static void removeFile(const std::string& path, bool force, bool interactive);
-    static void removeDirectoryRecursive(const std::string& path, bool force, bool interactive);
+    bool confirmDeletion(const std::string& path, bool interactive);
+    static bool isHidden(const std::string& fileName);
+    bool confirmChange(const std::string& path, bool interactive);
+    void removeFile(const std::string& path, bool force, bool interactive);
+    void removeDirectoryRecursive(const std::string& path, bool force, bool interactive);
 
-    static void printError(const std::string& message);
-    static void printWarning(const std::string& message);
-    static void printMessage(const std::string& message);
+    void printError(const std::string& message);
+    void printWarning(const std::string& message);
+    void printMessage(const std::string& message);
 
     static std::vector<std::string> tokenize(const std::string& input);
-    static void printUsage(const std::string& command);
+    void printUsage(const std::string& command);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,47 @@
+#include <mutex>
+#include <system_error>
+
+#include <sys/stat.h>
+
+#include "DirectoryCache.h"
+
+DirectoryCache::Listing DirectoryCache::list(const fs::path& directory) {
+    struct stat st{};
+    if (::stat(directory.c_str(), &st) < 0) {
+        throw fs::filesystem_error("cannot access directory", directory, std::error_code(errno, std::generic_category()));
+    }
+
+    const std::string key = directory.string();
+    {
+        std::shared_lock lock(mutex);
+        auto it = listings.find(key);
+        if (it != listings.end() && it->second.device == st.st_dev && it->second.inode == st.st_ino
+            && it->second.modified.tv_sec == st.st_mtim.tv_sec && it->second.modified.tv_nsec == st.st_mtim.tv_nsec) {
+            return it->second.entries;
+        }
+    }
+
+    auto entries = std::make_shared<std::vector<DirectoryEntry>>();
+    for (const auto& entry : fs::directory_iterator(directory)) {
+        DirectoryEntry cached;
+        cached.name = entry.path().filename().string();
+        std::error_code ec;
+        cached.symlink = entry.is_symlink(ec);
+        cached.directory = entry.is_directory(ec);
+        cached.regular = entry.is_regular_file(ec);
+        entries->push_back(std::move(cached));
+    }
+
+    // A change landing in the same timestamp tick as our read would leave the
+    // mtime untouched, so listings of recently modified directories are not kept.
+    timespec now{};
+    clock_gettime(CLOCK_REALTIME, &now);
+    if (now.tv_sec - st.st_mtim.tv_sec < 2) {
+        return entries;
+    }
+
+    std::unique_lock lock(mutex);
+    if (listings.size() >= maxDirectories) listings.clear();
+    listings[key] = CachedListing{st.st_dev, st.st_ino, st.st_mtim, entries};
+    return entries;
+}
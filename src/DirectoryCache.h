@@ -0,0 +1,46 @@
+#ifndef DIRECTORYCACHE_H
+#define DIRECTORYCACHE_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <shared_mutex>
+#include <unordered_map>
+#include <filesystem>
+#include <ctime>
+
+#include <sys/types.h>
+
+namespace fs = std::filesystem;
+
+struct DirectoryEntry {
+    std::string name;
+    bool directory = false;
+    bool symlink = false;
+    bool regular = false;
+};
+
+// Thread-safe cache of directory listings shared by every CommandHandler in a
+// process. A listing is reused while the directory's inode and mtime are
+// unchanged, so entries created or removed by anyone are picked up.
+class DirectoryCache {
+public:
+    using Listing = std::shared_ptr<const std::vector<DirectoryEntry>>;
+
+    Listing list(const fs::path& directory);
+
+private:
+    struct CachedListing {
+        dev_t device;
+        ino_t inode;
+        timespec modified;
+        Listing entries;
+    };
+
+    static constexpr std::size_t maxDirectories = 4096;
+
+    std::shared_mutex mutex;
+    std::unordered_map<std::string, CachedListing> listings;
+};
+
+#endif
@@ -0,0 +1,530 @@
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <streambuf>
+#include <functional>
+#include <filesystem>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "Server.h"
+#include "CommandHandler.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Output stream buffer that hands its contents to `sink` in chunks of at most
+// one frame payload, so a command's output never accumulates in memory.
+class FrameStreamBuf : public std::streambuf {
+public:
+    using Sink = std::function<void(char channel, const std::string& payload)>;
+
+    FrameStreamBuf(char channel, Sink sink) : channel(channel), sink(std::move(sink)) {}
+
+    void flushFrame() {
+        if (buffer.empty()) return;
+        sink(channel, buffer);
+        buffer.clear();
+    }
+
+protected:
+    int_type overflow(int_type ch) override {
+        if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+            buffer += traits_type::to_char_type(ch);
+            if (buffer.size() >= Protocol::MaxFramePayload) flushFrame();
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    std::streamsize xsputn(const char* data, std::streamsize count) override {
+        auto remaining = static_cast<std::size_t>(count);
+        while (remaining > 0) {
+            std::size_t chunk = std::min(remaining, Protocol::MaxFramePayload - buffer.size());
+            buffer.append(data, chunk);
+            data += chunk;
+            remaining -= chunk;
+            if (buffer.size() >= Protocol::MaxFramePayload) flushFrame();
+        }
+        return count;
+    }
+
+private:
+    char channel;
+    Sink sink;
+    std::string buffer;
+};
+
+} // namespace
+
+struct Server::Connection : std::enable_shared_from_this<Connection> {
+    Connection(int fd, Server& server, const std::shared_ptr<DirectoryCache>& cache)
+        : fd(fd),
+          outBuffer(Protocol::FrameStdout, [this, &server](char channel, const std::string& payload) {
+              std::string frame;
+              appendFrame(frame, channel, payload);
+              server.publish(shared_from_this(), std::move(frame), false);
+          }),
+          errBuffer(Protocol::FrameStderr, [this, &server](char channel, const std::string& payload) {
+              std::string frame;
+              appendFrame(frame, channel, payload);
+              server.publish(shared_from_this(), std::move(frame), false);
+          }),
+          out(&outBuffer), err(&errBuffer),
+          handler(cache, out, err, in, fs::current_path()) {}
+
+    int fd;
+    std::string input;
+    std::size_t inputStart = 0;
+    std::size_t scanned = 0;
+    std::string output;
+    std::string command;
+    bool busy = false;
+    bool closed = false;
+    bool peerFinished = false;
+    bool watchingReads = true;
+    bool watchingWrites = false;
+
+    // Guarded by Server::mutex: bytes published by the worker but not yet sent,
+    // and whether the event loop has dropped the connection.
+    std::size_t unsentBytes = 0;
+    bool abandoned = false;
+
+    // Only touched by the worker running `command`; interactive prompts read
+    // from an empty stream and are therefore declined.
+    FrameStreamBuf outBuffer;
+    FrameStreamBuf errBuffer;
+    std::ostream out;
+    std::ostream err;
+    std::istringstream in;
+    CommandHandler handler;
+
+    std::size_t pendingInput() const {
+        return input.size() - inputStart;
+    }
+
+    // Finds the end of the next command line, resuming where the last scan stopped.
+    std::size_t findNewline() {
+        std::size_t pos = input.find('\n', scanned);
+        scanned = pos == std::string::npos ? input.size() : pos;
+        return pos;
+    }
+
+    std::string takeLine(std::size_t newline) {
+        std::string line = input.substr(inputStart, newline - inputStart);
+        inputStart = scanned = newline + 1;
+        return line;
+    }
+
+    void compactInput() {
+        input.erase(0, inputStart);
+        scanned -= inputStart;
+        inputStart = 0;
+    }
+};
+
+Server::Server(std::string socketPath)
+    : socketPath(std::move(socketPath)), directoryCache(std::make_shared<DirectoryCache>()) {}
+
+int Server::run() {
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    if (!openSocket()) {
+        shutdown();
+        return 1;
+    }
+
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    signalFd = signalfd(-1, &signals, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (epollFd < 0 || wakeFd < 0 || signalFd < 0) {
+        std::cerr << "Error: cannot set up event loop: " << std::strerror(errno) << std::endl;
+        shutdown();
+        return 1;
+    }
+
+    for (int fd : {listenFd, wakeFd, signalFd}) {
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+    }
+
+    unsigned workerCount = std::max(2u, std::thread::hardware_concurrency());
+    for (unsigned i = 0; i < workerCount; ++i) {
+        workers.emplace_back([this] { workerLoop(); });
+    }
+
+    std::cout << "FileManager serving on " << socketPath << " with " << workerCount << " workers" << std::endl;
+    eventLoop();
+    shutdown();
+    std::cout << "Bye!" << std::endl;
+    return 0;
+}
+
+bool Server::openSocket() {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        std::cerr << "Error: socket path too long: " << socketPath << std::endl;
+        return false;
+    }
+    std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+
+    listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd < 0) {
+        std::cerr << "Error: cannot create socket: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    std::error_code ec;
+    if (fs::is_socket(socketPath, ec)) {
+        int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        bool inUse = connect(probe, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+        close(probe);
+        if (inUse) {
+            std::cerr << "Error: another server is already listening on " << socketPath << std::endl;
+            return false;
+        }
+        fs::remove(socketPath, ec);
+    }
+
+    mode_t previousMask = umask(0077);
+    int bound = bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    umask(previousMask);
+
+    if (bound < 0 || listen(listenFd, SOMAXCONN) < 0) {
+        std::cerr << "Error: cannot listen on " << socketPath << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void Server::eventLoop() {
+    constexpr int maxEvents = 64;
+    epoll_event events[maxEvents];
+
+    while (true) {
+        int count = epoll_wait(epollFd, events, maxEvents, acceptPaused ? acceptRetryMs : -1);
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "Error: epoll_wait failed: " << std::strerror(errno) << std::endl;
+            return;
+        }
+        if (count == 0) resumeAccepting();
+
+        for (int i = 0; i < count; ++i) {
+            int fd = events[i].data.fd;
+
+            if (fd == signalFd) {
+                return;
+            }
+            if (fd == listenFd) {
+                acceptConnections();
+                continue;
+            }
+            if (fd == wakeFd) {
+                std::uint64_t counter;
+                while (read(wakeFd, &counter, sizeof(counter)) > 0) {}
+                drainCompletions();
+                continue;
+            }
+
+            auto it = connections.find(fd);
+            if (it == connections.end()) continue;
+            std::shared_ptr<Connection> connection = it->second;
+
+            if (events[i].events & (EPOLLHUP | EPOLLERR)) {
+                closeConnection(connection);
+                continue;
+            }
+            if (events[i].events & EPOLLOUT) {
+                flush(connection);
+                dispatchNext(connection);
+            }
+            if (events[i].events & (EPOLLIN | EPOLLRDHUP)) readFrom(connection);
+        }
+    }
+}
+
+void Server::shutdown() {
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+    }
+    jobsChanged.notify_all();
+    outputDrained.notify_all();
+    for (auto& worker : workers) worker.join();
+    workers.clear();
+
+    for (auto& [fd, connection] : connections) close(fd);
+    connections.clear();
+
+    for (int* fd : {&listenFd, &epollFd, &wakeFd, &signalFd}) {
+        if (*fd >= 0) close(*fd);
+        *fd = -1;
+    }
+
+    std::error_code ec;
+    if (fs::is_socket(socketPath, ec)) fs::remove(socketPath, ec);
+}
+
+void Server::acceptConnections() {
+    while (true) {
+        int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM) {
+                // The pending connection stays queued and keeps the listening
+                // socket readable, so stop watching it until descriptors free up.
+                std::cerr << "Warning: accept failed: " << std::strerror(errno) << "; pausing new connections" << std::endl;
+                epoll_ctl(epollFd, EPOLL_CTL_DEL, listenFd, nullptr);
+                acceptPaused = true;
+            } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                std::cerr << "Warning: accept failed: " << std::strerror(errno) << std::endl;
+            }
+            return;
+        }
+
+        auto connection = std::make_shared<Connection>(fd, *this, directoryCache);
+        connections[fd] = connection;
+
+        epoll_event event{};
+        event.events = EPOLLIN | EPOLLRDHUP;
+        event.data.fd = fd;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+    }
+}
+
+void Server::resumeAccepting() {
+    if (!acceptPaused) return;
+    acceptPaused = false;
+
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = listenFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event);
+}
+
+void Server::readFrom(const std::shared_ptr<Connection>& connection) {
+    if (connection->closed) return;
+
+    char buffer[16 * 1024];
+    connection->compactInput();
+
+    while (connection->input.size() < maxLineLength) {
+        ssize_t got = read(connection->fd, buffer, sizeof(buffer));
+        if (got > 0) {
+            connection->input.append(buffer, static_cast<std::size_t>(got));
+            continue;
+        }
+        if (got < 0 && errno == EINTR) continue;
+        if (got < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (got < 0) {
+            closeConnection(connection);
+            return;
+        }
+
+        // The peer may half-close after sending its commands; answer them first.
+        connection->peerFinished = true;
+        break;
+    }
+
+    if (connection->input.size() >= maxLineLength && connection->findNewline() == std::string::npos) {
+        closeConnection(connection);
+        return;
+    }
+
+    dispatchNext(connection);
+}
+
+void Server::dispatchNext(const std::shared_ptr<Connection>& connection) {
+    while (!connection->busy && !connection->closed && connection->output.size() < outputHighWater) {
+        std::size_t newline = connection->findNewline();
+        if (newline == std::string::npos) break;
+
+        std::string line = connection->takeLine(newline);
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+
+        // "exit" behaves like a half-close: anything after it is ignored and the
+        // connection closes once the replies already queued have been sent.
+        if (line == "exit") {
+            connection->input.clear();
+            connection->inputStart = connection->scanned = 0;
+            connection->peerFinished = true;
+            break;
+        }
+        if (line.empty()) {
+            appendFrame(connection->output, Protocol::FrameDone, "");
+            continue;
+        }
+
+        connection->command = std::move(line);
+        connection->busy = true;
+        {
+            std::lock_guard lock(mutex);
+            jobs.push_back(connection);
+        }
+        jobsChanged.notify_one();
+    }
+
+    flush(connection);
+}
+
+void Server::flush(const std::shared_ptr<Connection>& connection) {
+    if (connection->closed) return;
+
+    while (!connection->output.empty()) {
+        ssize_t sent = send(connection->fd, connection->output.data(), connection->output.size(), MSG_NOSIGNAL);
+        if (sent > 0) {
+            connection->output.erase(0, static_cast<std::size_t>(sent));
+            {
+                std::lock_guard lock(mutex);
+                connection->unsentBytes -= std::min(connection->unsentBytes, static_cast<std::size_t>(sent));
+            }
+            outputDrained.notify_all();
+            continue;
+        }
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+
+        closeConnection(connection);
+        return;
+    }
+
+    // A half-closed peer is disconnected once everything it sent has been answered.
+    if (connection->peerFinished && !connection->busy && connection->output.empty()
+        && connection->findNewline() == std::string::npos) {
+        closeConnection(connection);
+        return;
+    }
+    updateInterest(connection);
+}
+
+void Server::updateInterest(const std::shared_ptr<Connection>& connection) {
+    if (connection->closed) return;
+
+    // Stop reading while a command runs or replies pile up, so a client that
+    // pipelines without reading cannot grow the buffers without bound.
+    bool wantReads = !connection->peerFinished && !connection->busy
+                     && connection->output.size() < outputHighWater
+                     && connection->pendingInput() < maxLineLength;
+    bool wantWrites = !connection->output.empty();
+    if (wantReads == connection->watchingReads && wantWrites == connection->watchingWrites) return;
+
+    epoll_event event{};
+    if (wantReads) event.events |= EPOLLIN | EPOLLRDHUP;
+    if (wantWrites) event.events |= EPOLLOUT;
+    event.data.fd = connection->fd;
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, connection->fd, &event);
+    connection->watchingReads = wantReads;
+    connection->watchingWrites = wantWrites;
+}
+
+void Server::closeConnection(const std::shared_ptr<Connection>& connection) {
+    if (connection->closed) return;
+    connection->closed = true;
+
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, connection->fd, nullptr);
+    close(connection->fd);
+    connections.erase(connection->fd);
+    resumeAccepting();
+
+    {
+        std::lock_guard lock(mutex);
+        connection->abandoned = true;
+    }
+    outputDrained.notify_all();
+}
+
+void Server::drainCompletions() {
+    std::vector<Completion> ready;
+    {
+        std::lock_guard lock(mutex);
+        ready.swap(completions);
+    }
+
+    for (auto& completion : ready) {
+        const auto& connection = completion.connection;
+        if (completion.finished) connection->busy = false;
+        if (connection->closed) continue;
+
+        connection->output += completion.response;
+        dispatchNext(connection);
+    }
+}
+
+void Server::workerLoop() {
+    while (true) {
+        std::shared_ptr<Connection> connection;
+        {
+            std::unique_lock lock(mutex);
+            jobsChanged.wait(lock, [this] { return stopping || !jobs.empty(); });
+            if (stopping) return;
+            connection = std::move(jobs.front());
+            jobs.pop_front();
+        }
+
+        try {
+            connection->handler.parseAndExecute(connection->command);
+        } catch (const std::exception& e) {
+            connection->err << "Error: " << e.what() << std::endl;
+        }
+
+        connection->outBuffer.flushFrame();
+        connection->errBuffer.flushFrame();
+        connection->in.clear();
+
+        std::string done;
+        appendFrame(done, Protocol::FrameDone, "");
+        publish(connection, std::move(done), true);
+    }
+}
+
+// Hands frames to the event loop. Blocks the calling worker while the client
+// has not yet received a high-water mark's worth of earlier output.
+void Server::publish(const std::shared_ptr<Connection>& connection, std::string frames, bool finished) {
+    {
+        std::unique_lock lock(mutex);
+        outputDrained.wait(lock, [&] {
+            return stopping || connection->abandoned || connection->unsentBytes < outputHighWater;
+        });
+        if ((stopping || connection->abandoned) && !finished) return;
+
+        connection->unsentBytes += frames.size();
+        completions.push_back({connection, std::move(frames), finished});
+    }
+    std::uint64_t one = 1;
+    ssize_t woken = write(wakeFd, &one, sizeof(one));
+    (void) woken;
+}
+
+void Server::appendFrame(std::string& buffer, char channel, const std::string& payload) {
+    if (payload.empty() && channel != Protocol::FrameDone) return;
+
+    std::size_t offset = 0;
+    do {
+        std::size_t chunk = std::min(payload.size() - offset, Protocol::MaxFramePayload);
+        auto length = static_cast<std::uint32_t>(chunk);
+        buffer += channel;
+        buffer += static_cast<char>((length >> 24) & 0xff);
+        buffer += static_cast<char>((length >> 16) & 0xff);
+        buffer += static_cast<char>((length >> 8) & 0xff);
+        buffer += static_cast<char>(length & 0xff);
+        buffer.append(payload, offset, chunk);
+        offset += chunk;
+    } while (offset < payload.size());
+}
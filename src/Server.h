@@ -0,0 +1,87 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <unordered_map>
+
+#include "DirectoryCache.h"
+
+// Wire format shared by Server and Client. The client sends newline-terminated
+// command lines; every command is answered with a sequence of frames, each a
+// channel byte, a 4-byte big-endian length and at most MaxFramePayload bytes of
+// payload, ending with an empty FrameDone frame. Frames are streamed while the
+// command is still running.
+namespace Protocol {
+    constexpr char FrameStdout = 'o';
+    constexpr char FrameStderr = 'e';
+    constexpr char FrameDone = 'd';
+    constexpr std::size_t FrameHeaderSize = 5;
+    constexpr std::size_t MaxFramePayload = 64 * 1024;
+}
+
+// Long-lived daemon serving commands on a Unix-domain socket. A single epoll
+// loop owns every connection; commands run on a worker pool, each connection
+// with its own CommandHandler (working directory and output streams) and all of
+// them sharing one DirectoryCache.
+class Server {
+public:
+    explicit Server(std::string socketPath);
+
+    int run();
+
+private:
+    struct Connection;
+
+    struct Completion {
+        std::shared_ptr<Connection> connection;
+        std::string response;
+        bool finished;
+    };
+
+    static constexpr std::size_t maxLineLength = 1024 * 1024;
+    static constexpr std::size_t outputHighWater = 256 * 1024;
+    static constexpr int acceptRetryMs = 1000;
+
+    std::string socketPath;
+    std::shared_ptr<DirectoryCache> directoryCache;
+    int listenFd = -1;
+    int epollFd = -1;
+    int wakeFd = -1;
+    int signalFd = -1;
+    bool acceptPaused = false;
+
+    std::unordered_map<int, std::shared_ptr<Connection>> connections;
+
+    std::mutex mutex;
+    std::condition_variable jobsChanged;
+    std::condition_variable outputDrained;
+    std::deque<std::shared_ptr<Connection>> jobs;
+    std::vector<Completion> completions;
+    bool stopping = false;
+    std::vector<std::thread> workers;
+
+    bool openSocket();
+    void eventLoop();
+    void shutdown();
+
+    void acceptConnections();
+    void resumeAccepting();
+    void readFrom(const std::shared_ptr<Connection>& connection);
+    void dispatchNext(const std::shared_ptr<Connection>& connection);
+    void flush(const std::shared_ptr<Connection>& connection);
+    void updateInterest(const std::shared_ptr<Connection>& connection);
+    void closeConnection(const std::shared_ptr<Connection>& connection);
+    void drainCompletions();
+    void workerLoop();
+    void publish(const std::shared_ptr<Connection>& connection, std::string frames, bool finished);
+
+    static void appendFrame(std::string& buffer, char channel, const std::string& payload);
+};
+
+#endif
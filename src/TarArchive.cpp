@@ -0,0 +1,863 @@
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <climits>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "TarArchive.h"
+
+namespace {
+
+constexpr std::size_t kBlockSize = 512;
+constexpr std::size_t kWindowSize = 64;
+constexpr std::size_t kCopyBufferSize = 64 * 1024;
+constexpr std::size_t kMaxPaxHeaderSize = 1024 * 1024;
+constexpr off_t kPrefetchBytes = 4 * 1024 * 1024;
+
+struct UstarHeader {
+    char name[100];
+    char mode[8];
+    char uid[8];
+    char gid[8];
+    char size[12];
+    char mtime[12];
+    char chksum[8];
+    char typeflag;
+    char linkname[100];
+    char magic[6];
+    char version[2];
+    char uname[32];
+    char gname[32];
+    char devmajor[8];
+    char devminor[8];
+    char prefix[155];
+    char pad[12];
+};
+
+static_assert(sizeof(UstarHeader) == kBlockSize, "ustar header must be one block");
+
+[[noreturn]] void throwErrno(const std::string& what, const fs::path& path) {
+    throw fs::filesystem_error(what, path, std::error_code(errno, std::generic_category()));
+}
+
+std::string errnoMessage(const std::string& what, const std::string& name) {
+    return what + " '" + name + "': " + std::strerror(errno);
+}
+
+std::uint64_t paddingFor(std::uint64_t size) {
+    return (kBlockSize - size % kBlockSize) % kBlockSize;
+}
+
+void writeAll(int fd, const char* data, std::size_t length, const fs::path& path) {
+    while (length > 0) {
+        ssize_t written = ::write(fd, data, length);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            throwErrno("write failed", path);
+        }
+        data += written;
+        length -= static_cast<std::size_t>(written);
+    }
+}
+
+void writeZeros(int fd, std::uint64_t length, const fs::path& path) {
+    static const std::array<char, kBlockSize> zeros{};
+    while (length > 0) {
+        std::size_t chunk = std::min<std::uint64_t>(length, zeros.size());
+        writeAll(fd, zeros.data(), chunk, path);
+        length -= chunk;
+    }
+}
+
+bool readFullyAt(int fd, char* data, std::size_t length, off_t offset) {
+    while (length > 0) {
+        ssize_t got = ::pread(fd, data, length, offset);
+        if (got < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        if (got == 0) {
+            errno = EIO;
+            return false;
+        }
+        data += got;
+        offset += got;
+        length -= static_cast<std::size_t>(got);
+    }
+    return true;
+}
+
+bool writeOctal(char* field, std::size_t width, std::uint64_t value) {
+    std::uint64_t limit = 1;
+    for (std::size_t i = 0; i + 1 < width; ++i) limit *= 8;
+    if (value >= limit) return false;
+
+    field[width - 1] = '\0';
+    for (std::size_t i = width - 1; i > 0; --i) {
+        field[i - 1] = static_cast<char>('0' + (value & 7));
+        value >>= 3;
+    }
+    return true;
+}
+
+// Parses an octal or base-256 numeric field, saturating at UINT64_MAX so that
+// oversized values are caught by the caller's range checks.
+std::uint64_t parseNumber(const char* field, std::size_t width) {
+    constexpr std::uint64_t kMax = std::numeric_limits<std::uint64_t>::max();
+    std::uint64_t value = 0;
+    auto bytes = reinterpret_cast<const unsigned char*>(field);
+
+    if (bytes[0] & 0x80) {
+        value = bytes[0] & 0x7f;
+        for (std::size_t i = 1; i < width; ++i) {
+            if (value > (kMax >> 8)) return kMax;
+            value = (value << 8) | bytes[i];
+        }
+        return value;
+    }
+
+    std::size_t i = 0;
+    while (i < width && (field[i] == ' ' || field[i] == '\0')) ++i;
+    for (; i < width && field[i] >= '0' && field[i] <= '7'; ++i) {
+        value = value * 8 + static_cast<std::uint64_t>(field[i] - '0');
+    }
+    return value;
+}
+
+std::string fieldString(const char* field, std::size_t width) {
+    return {field, strnlen(field, width)};
+}
+
+unsigned computeChecksum(const UstarHeader& header) {
+    UstarHeader copy = header;
+    std::memset(copy.chksum, ' ', sizeof(copy.chksum));
+
+    unsigned sum = 0;
+    for (unsigned char byte : std::string_view(reinterpret_cast<const char*>(&copy), sizeof(copy))) {
+        sum += byte;
+    }
+    return sum;
+}
+
+void finalizeHeader(UstarHeader& header) {
+    std::memcpy(header.magic, "ustar", 6);
+    std::memcpy(header.version, "00", 2);
+    writeOctal(header.chksum, 7, computeChecksum(header));
+    header.chksum[7] = ' ';
+}
+
+bool splitName(const std::string& name, UstarHeader& header) {
+    if (name.size() <= sizeof(header.name)) {
+        std::memcpy(header.name, name.data(), name.size());
+        return true;
+    }
+
+    for (std::size_t pos = name.find('/'); pos != std::string::npos; pos = name.find('/', pos + 1)) {
+        std::size_t rest = name.size() - pos - 1;
+        if (pos <= sizeof(header.prefix) && rest > 0 && rest <= sizeof(header.name)) {
+            std::memcpy(header.prefix, name.data(), pos);
+            std::memcpy(header.name, name.data() + pos + 1, rest);
+            return true;
+        }
+    }
+
+    std::memcpy(header.name, name.data(), sizeof(header.name));
+    return false;
+}
+
+std::string paxRecord(const std::string& key, const std::string& value) {
+    std::string body = " " + key + "=" + value + "\n";
+    std::size_t length = body.size();
+    while (std::to_string(length).size() + body.size() != length) {
+        length = std::to_string(length).size() + body.size();
+    }
+    return std::to_string(length) + body;
+}
+
+void writeHeader(int out, const fs::path& archive, const std::string& name, char type,
+                 const struct stat& st, const std::string& linkName, std::uint64_t size) {
+    UstarHeader header{};
+    std::string pax;
+
+    if (!splitName(name, header)) pax += paxRecord("path", name);
+
+    if (linkName.size() > sizeof(header.linkname)) {
+        pax += paxRecord("linkpath", linkName);
+        std::memcpy(header.linkname, linkName.data(), sizeof(header.linkname));
+    } else {
+        std::memcpy(header.linkname, linkName.data(), linkName.size());
+    }
+
+    if (!writeOctal(header.size, sizeof(header.size), size)) {
+        pax += paxRecord("size", std::to_string(size));
+        writeOctal(header.size, sizeof(header.size), 0);
+    }
+
+    writeOctal(header.mode, sizeof(header.mode), st.st_mode & 07777);
+    if (!writeOctal(header.uid, sizeof(header.uid), st.st_uid)) writeOctal(header.uid, sizeof(header.uid), 0);
+    if (!writeOctal(header.gid, sizeof(header.gid), st.st_gid)) writeOctal(header.gid, sizeof(header.gid), 0);
+    writeOctal(header.mtime, sizeof(header.mtime), st.st_mtime > 0 ? static_cast<std::uint64_t>(st.st_mtime) : 0);
+    header.typeflag = type;
+
+    if (!pax.empty()) {
+        UstarHeader paxHeader{};
+        std::string paxName = "PaxHeaders/" + fs::path(name).filename().string();
+        paxName.resize(std::min(paxName.size(), sizeof(paxHeader.name)));
+        std::memcpy(paxHeader.name, paxName.data(), paxName.size());
+        writeOctal(paxHeader.mode, sizeof(paxHeader.mode), 0644);
+        writeOctal(paxHeader.uid, sizeof(paxHeader.uid), 0);
+        writeOctal(paxHeader.gid, sizeof(paxHeader.gid), 0);
+        writeOctal(paxHeader.size, sizeof(paxHeader.size), pax.size());
+        writeOctal(paxHeader.mtime, sizeof(paxHeader.mtime), 0);
+        paxHeader.typeflag = 'x';
+        finalizeHeader(paxHeader);
+
+        writeAll(out, reinterpret_cast<const char*>(&paxHeader), kBlockSize, archive);
+        writeAll(out, pax.data(), pax.size(), archive);
+        writeZeros(out, paddingFor(pax.size()), archive);
+    }
+
+    finalizeHeader(header);
+    writeAll(out, reinterpret_cast<const char*>(&header), kBlockSize, archive);
+}
+
+// Streams `size` bytes from the current offset of `in` to the current offset
+// of `out`, preferring in-kernel copies. Returns the number of bytes copied,
+// which is short only if the source shrank while being archived.
+std::uint64_t streamFile(int in, int out, std::uint64_t size, const fs::path& archive) {
+    enum class Method { CopyFileRange, SendFile, ReadWrite } method = Method::CopyFileRange;
+    std::uint64_t copied = 0;
+    std::unique_ptr<char[]> buffer;
+
+    while (copied < size) {
+        std::size_t chunk = std::min<std::uint64_t>(size - copied, 1u << 30);
+        ssize_t moved = 0;
+
+        if (method == Method::CopyFileRange) {
+            moved = ::copy_file_range(in, nullptr, out, nullptr, chunk, 0);
+        } else if (method == Method::SendFile) {
+            moved = ::sendfile(out, in, nullptr, chunk);
+        } else {
+            if (!buffer) buffer = std::make_unique<char[]>(kCopyBufferSize);
+            moved = ::read(in, buffer.get(), std::min(chunk, kCopyBufferSize));
+            if (moved > 0) writeAll(out, buffer.get(), static_cast<std::size_t>(moved), archive);
+        }
+
+        if (moved < 0) {
+            if (errno == EINTR) continue;
+            bool unsupported = errno == EXDEV || errno == EINVAL || errno == ENOSYS
+                               || errno == EOPNOTSUPP || errno == EBADF;
+            if (unsupported && method != Method::ReadWrite) {
+                method = method == Method::CopyFileRange ? Method::SendFile : Method::ReadWrite;
+                continue;
+            }
+            throwErrno("copy failed", archive);
+        }
+        if (moved == 0) break;
+        copied += static_cast<std::uint64_t>(moved);
+    }
+    return copied;
+}
+
+// Copies `size` bytes between explicit offsets so that many workers can share
+// one input descriptor without seeking it.
+bool copyRange(int in, off_t inOffset, int out, std::uint64_t size) {
+    off_t outOffset = 0;
+    bool useCopyFileRange = true;
+    std::unique_ptr<char[]> buffer;
+
+    while (size > 0) {
+        std::size_t chunk = std::min<std::uint64_t>(size, 1u << 30);
+        ssize_t moved;
+
+        if (useCopyFileRange) {
+            moved = ::copy_file_range(in, &inOffset, out, &outOffset, chunk, 0);
+            if (moved < 0 && errno != EINTR) {
+                if (errno == EXDEV || errno == EINVAL || errno == ENOSYS || errno == EOPNOTSUPP) {
+                    useCopyFileRange = false;
+                    continue;
+                }
+                return false;
+            }
+        } else {
+            if (!buffer) buffer = std::make_unique<char[]>(kCopyBufferSize);
+            chunk = std::min(chunk, kCopyBufferSize);
+            if (!readFullyAt(in, buffer.get(), chunk, inOffset)) return false;
+            for (std::size_t done = 0; done < chunk;) {
+                ssize_t written = ::pwrite(out, buffer.get() + done, chunk - done, outOffset);
+                if (written < 0) {
+                    if (errno == EINTR) continue;
+                    return false;
+                }
+                done += static_cast<std::size_t>(written);
+                outOffset += written;
+            }
+            inOffset += static_cast<off_t>(chunk);
+            moved = static_cast<ssize_t>(chunk);
+        }
+
+        if (moved < 0) continue;
+        if (moved == 0) {
+            errno = EIO;
+            return false;
+        }
+        size -= static_cast<std::uint64_t>(moved);
+    }
+    return true;
+}
+
+std::string archiveName(const std::string& argument) {
+    fs::path normal = fs::path(argument).lexically_normal().relative_path();
+    fs::path result;
+    for (const auto& part : normal) {
+        if (part == ".." || part == ".") continue;
+        if (part.empty()) continue;
+        result /= part;
+    }
+    return result.generic_string();
+}
+
+std::optional<std::vector<std::string>> sanitizeMemberName(const std::string& name) {
+    std::vector<std::string> parts;
+    std::size_t start = 0;
+    while (start <= name.size()) {
+        std::size_t end = name.find('/', start);
+        if (end == std::string::npos) end = name.size();
+        std::string part = name.substr(start, end - start);
+        if (part == "..") return std::nullopt;
+        if (!part.empty() && part != ".") parts.push_back(part);
+        start = end + 1;
+    }
+    if (parts.empty()) return std::nullopt;
+    return parts;
+}
+
+// Opens the directory holding the last component of `parts`, creating any
+// missing intermediate directories. Every step refuses to follow symlinks so
+// that a crafted archive cannot redirect writes outside the destination.
+int openParentDirectory(int root, const std::vector<std::string>& parts, std::size_t depth) {
+    int current = ::dup(root);
+    for (std::size_t i = 0; i < depth && current >= 0; ++i) {
+        if (::mkdirat(current, parts[i].c_str(), 0755) < 0 && errno != EEXIST) {
+            ::close(current);
+            return -1;
+        }
+        int next = ::openat(current, parts[i].c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+        int savedErrno = errno;
+        ::close(current);
+        errno = savedErrno;
+        current = next;
+    }
+    return current;
+}
+
+struct PackSlot {
+    fs::path source;
+    std::string name;
+    std::string error;
+    std::string linkTarget;
+    struct stat st{};
+    int fd = -1;
+    bool ready = false;
+
+    PackSlot() = default;
+    PackSlot(const PackSlot&) = delete;
+    PackSlot& operator=(const PackSlot&) = delete;
+    ~PackSlot() {
+        if (fd >= 0) ::close(fd);
+    }
+};
+
+void prefetchSlot(PackSlot& slot) {
+    if (!slot.error.empty()) return;
+
+    if (::lstat(slot.source.c_str(), &slot.st) < 0) {
+        slot.error = errnoMessage("pack: cannot stat", slot.source.string());
+        return;
+    }
+
+    if (S_ISREG(slot.st.st_mode)) {
+        slot.fd = ::open(slot.source.c_str(), O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+        if (slot.fd < 0 || ::fstat(slot.fd, &slot.st) < 0) {
+            slot.error = errnoMessage("pack: cannot open", slot.source.string());
+            if (slot.fd >= 0) ::close(slot.fd);
+            slot.fd = -1;
+            return;
+        }
+        ::posix_fadvise(slot.fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+        ::posix_fadvise(slot.fd, 0, std::min<off_t>(slot.st.st_size, kPrefetchBytes), POSIX_FADV_WILLNEED);
+    } else if (S_ISLNK(slot.st.st_mode)) {
+        std::string target(static_cast<std::size_t>(slot.st.st_size > 0 ? slot.st.st_size : PATH_MAX) + 1, '\0');
+        ssize_t length = ::readlink(slot.source.c_str(), target.data(), target.size());
+        if (length < 0) {
+            slot.error = errnoMessage("pack: cannot read link", slot.source.string());
+            return;
+        }
+        target.resize(static_cast<std::size_t>(length));
+        slot.linkTarget = std::move(target);
+    }
+}
+
+struct UnpackJob {
+    std::string name;
+    std::string leaf;
+    int parent;
+    int fd;
+    off_t offset;
+    std::uint64_t size;
+    struct timespec times[2];
+};
+
+} // namespace
+
+unsigned TarArchive::workerCount() {
+    return std::max(2u, std::thread::hardware_concurrency());
+}
+
+ArchiveStats TarArchive::pack(const fs::path& archive, const fs::path& base, const std::vector<std::string>& paths,
+                              const ArchiveLogger& onEntry, const ArchiveLogger& onWarning) {
+    int out = ::open(archive.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (out < 0) throwErrno("pack: cannot create archive", archive);
+
+    struct stat archiveStat{};
+    ::fstat(out, &archiveStat);
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<std::shared_ptr<PackSlot>> window;
+    std::deque<std::shared_ptr<PackSlot>> pending;
+    bool walkDone = false;
+    bool aborted = false;
+
+    auto enqueue = [&](std::shared_ptr<PackSlot> slot) {
+        std::unique_lock lock(mutex);
+        changed.wait(lock, [&] { return aborted || window.size() < kWindowSize; });
+        if (aborted) return false;
+        window.push_back(slot);
+        pending.push_back(std::move(slot));
+        changed.notify_all();
+        return true;
+    };
+
+    std::thread walker([&] {
+        for (const auto& argument : paths) {
+            std::string prefix = archiveName(argument);
+            const fs::path source = base / argument;
+            auto root = std::make_shared<PackSlot>();
+            root->source = source;
+            root->name = prefix;
+
+            std::error_code ec;
+            fs::file_status status = fs::symlink_status(source, ec);
+            if (ec || !fs::exists(status)) {
+                root->error = "pack: cannot stat '" + argument + "': " + (ec ? ec.message() : "No such file or directory");
+            }
+            if ((!prefix.empty() || !root->error.empty()) && !enqueue(root)) break;
+            if (!root->error.empty() || !fs::is_directory(status)) continue;
+
+            fs::recursive_directory_iterator it(source, fs::directory_options::skip_permission_denied, ec);
+            for (; !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+                auto slot = std::make_shared<PackSlot>();
+                slot->source = it->path();
+                std::string relative = it->path().lexically_relative(source).generic_string();
+                slot->name = prefix.empty() ? relative : prefix + "/" + relative;
+                if (!enqueue(std::move(slot))) break;
+            }
+            if (ec) {
+                auto slot = std::make_shared<PackSlot>();
+                slot->error = "pack: cannot read directory '" + argument + "': " + ec.message();
+                if (!enqueue(std::move(slot))) break;
+            }
+        }
+
+        std::lock_guard lock(mutex);
+        walkDone = true;
+        changed.notify_all();
+    });
+
+    std::vector<std::thread> readers;
+    for (unsigned i = 0; i < workerCount(); ++i) {
+        readers.emplace_back([&] {
+            while (true) {
+                std::shared_ptr<PackSlot> slot;
+                {
+                    std::unique_lock lock(mutex);
+                    changed.wait(lock, [&] { return aborted || !pending.empty() || walkDone; });
+                    if (aborted || (pending.empty() && walkDone)) return;
+                    slot = std::move(pending.front());
+                    pending.pop_front();
+                }
+                prefetchSlot(*slot);
+                std::lock_guard lock(mutex);
+                slot->ready = true;
+                changed.notify_all();
+            }
+        });
+    }
+
+    auto shutdown = [&] {
+        {
+            std::lock_guard lock(mutex);
+            aborted = true;
+            changed.notify_all();
+        }
+        walker.join();
+        for (auto& reader : readers) reader.join();
+        window.clear();
+        pending.clear();
+        ::close(out);
+    };
+
+    ArchiveStats stats;
+    try {
+        while (true) {
+            std::shared_ptr<PackSlot> slot;
+            {
+                std::unique_lock lock(mutex);
+                changed.wait(lock, [&] {
+                    return (!window.empty() && window.front()->ready) || (walkDone && window.empty());
+                });
+                if (window.empty()) break;
+                slot = std::move(window.front());
+                window.pop_front();
+                changed.notify_all();
+            }
+
+            if (!slot->error.empty()) {
+                onWarning(slot->error);
+                ++stats.skipped;
+                continue;
+            }
+
+            const struct stat& st = slot->st;
+            if (st.st_dev == archiveStat.st_dev && st.st_ino == archiveStat.st_ino) continue;
+
+            if (S_ISREG(st.st_mode)) {
+                auto size = static_cast<std::uint64_t>(st.st_size);
+                writeHeader(out, archive, slot->name, '0', st, "", size);
+                std::uint64_t copied = streamFile(slot->fd, out, size, archive);
+                if (copied < size) {
+                    onWarning("pack: file '" + slot->name + "' shrank while being archived");
+                    writeZeros(out, size - copied, archive);
+                }
+                writeZeros(out, paddingFor(size), archive);
+                stats.bytes += size;
+            } else if (S_ISDIR(st.st_mode)) {
+                writeHeader(out, archive, slot->name + "/", '5', st, "", 0);
+            } else if (S_ISLNK(st.st_mode)) {
+                writeHeader(out, archive, slot->name, '2', st, slot->linkTarget, 0);
+            } else {
+                onWarning("pack: skipping special file '" + slot->name + "'");
+                ++stats.skipped;
+                continue;
+            }
+
+            ++stats.entries;
+            onEntry(slot->name);
+        }
+
+        writeZeros(out, 2 * kBlockSize, archive);
+    } catch (...) {
+        shutdown();
+        throw;
+    }
+
+    shutdown();
+    return stats;
+}
+
+ArchiveStats TarArchive::unpack(const fs::path& archive, const fs::path& destination,
+                                const ArchiveLogger& onEntry, const ArchiveLogger& onWarning) {
+    int in = ::open(archive.c_str(), O_RDONLY | O_CLOEXEC);
+    if (in < 0) throwErrno("unpack: cannot open archive", archive);
+
+    struct stat archiveStat{};
+    if (::fstat(in, &archiveStat) < 0) {
+        int savedErrno = errno;
+        ::close(in);
+        errno = savedErrno;
+        throwErrno("unpack: cannot stat archive", archive);
+    }
+    const auto archiveSize = static_cast<std::uint64_t>(archiveStat.st_size);
+
+    std::error_code ec;
+    fs::create_directories(destination, ec);
+    int root = ::open(destination.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (root < 0) {
+        int savedErrno = errno;
+        ::close(in);
+        errno = savedErrno;
+        throwErrno("unpack: cannot open destination", destination);
+    }
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<UnpackJob> jobs;
+    std::vector<std::string> failures;
+    bool readDone = false;
+
+    std::vector<std::thread> writers;
+    for (unsigned i = 0; i < workerCount(); ++i) {
+        writers.emplace_back([&] {
+            while (true) {
+                UnpackJob job;
+                {
+                    std::unique_lock lock(mutex);
+                    changed.wait(lock, [&] { return !jobs.empty() || readDone; });
+                    if (jobs.empty()) return;
+                    job = jobs.front();
+                    jobs.pop_front();
+                    changed.notify_all();
+                }
+
+                bool ok = copyRange(in, job.offset, job.fd, job.size) && ::futimens(job.fd, job.times) == 0;
+                std::string failure = ok ? "" : errnoMessage("unpack: cannot write", job.name);
+                ::close(job.fd);
+                if (!ok) ::unlinkat(job.parent, job.leaf.c_str(), 0);
+                ::close(job.parent);
+
+                if (!ok) {
+                    std::lock_guard lock(mutex);
+                    failures.push_back(std::move(failure));
+                }
+            }
+        });
+    }
+
+    auto shutdown = [&] {
+        {
+            std::lock_guard lock(mutex);
+            readDone = true;
+            changed.notify_all();
+        }
+        for (auto& writer : writers) writer.join();
+        ::close(root);
+        ::close(in);
+    };
+
+    ArchiveStats stats;
+    try {
+        off_t offset = 0;
+        std::optional<std::string> overridePath;
+        std::optional<std::string> overrideLink;
+        std::optional<std::uint64_t> overrideSize;
+
+        auto readPayload = [&](off_t at, std::uint64_t size) {
+            if (size > kMaxPaxHeaderSize) {
+                throw std::runtime_error("unpack: extended header too large in '" + archive.string() + "'");
+            }
+            std::string payload(size, '\0');
+            if (!readFullyAt(in, payload.data(), payload.size(), at)) throwErrno("unpack: read failed", archive);
+            return payload;
+        };
+
+        while (true) {
+            if (static_cast<std::uint64_t>(offset) == archiveSize) {
+                onWarning("unpack: archive '" + archive.string() + "' ends without an end-of-archive marker");
+                break;
+            }
+
+            UstarHeader header{};
+            if (!readFullyAt(in, reinterpret_cast<char*>(&header), kBlockSize, offset)) {
+                throwErrno("unpack: truncated archive", archive);
+            }
+
+            const auto* raw = reinterpret_cast<const char*>(&header);
+            if (std::all_of(raw, raw + kBlockSize, [](char c) { return c == '\0'; })) break;
+
+            if (parseNumber(header.chksum, sizeof(header.chksum)) != computeChecksum(header)) {
+                throw std::runtime_error("unpack: invalid header checksum in '" + archive.string() + "'");
+            }
+
+            // A pax size record describes the next real member, never another
+            // extension header in between.
+            char type = header.typeflag;
+            bool extension = type == 'x' || type == 'g' || type == 'L' || type == 'K';
+            std::uint64_t size = parseNumber(header.size, sizeof(header.size));
+            if (overrideSize && !extension) size = *overrideSize;
+            off_t dataOffset = offset + static_cast<off_t>(kBlockSize);
+            if (size > archiveSize || static_cast<std::uint64_t>(dataOffset) > archiveSize - size) {
+                throw std::runtime_error("unpack: member extends past end of archive '" + archive.string() + "'");
+            }
+            offset = dataOffset + static_cast<off_t>(size + paddingFor(size));
+
+            if (type == 'x') {
+                const std::string invalidHeader = "unpack: invalid extended header in '" + archive.string() + "'";
+                std::string payload = readPayload(dataOffset, size);
+                for (std::size_t pos = 0; pos < payload.size();) {
+                    std::size_t space = payload.find(' ', pos);
+                    std::size_t length = 0;
+                    auto [end, error] = std::from_chars(payload.data() + pos, payload.data() + payload.size(), length);
+                    if (error != std::errc() || space == std::string::npos || end != payload.data() + space
+                        || length <= space - pos + 1 || length > payload.size() - pos || payload[pos + length - 1] != '\n') {
+                        throw std::runtime_error(invalidHeader);
+                    }
+                    std::string record = payload.substr(space + 1, pos + length - space - 2);
+                    std::size_t equals = record.find('=');
+                    if (equals != std::string::npos) {
+                        std::string key = record.substr(0, equals);
+                        std::string value = record.substr(equals + 1);
+                        if (key == "path") overridePath = value;
+                        else if (key == "linkpath") overrideLink = value;
+                        else if (key == "size") {
+                            std::uint64_t parsed = 0;
+                            auto [sizeEnd, sizeError] = std::from_chars(value.data(), value.data() + value.size(), parsed);
+                            if (sizeError != std::errc() || sizeEnd != value.data() + value.size()) {
+                                throw std::runtime_error(invalidHeader);
+                            }
+                            overrideSize = parsed;
+                        }
+                    }
+                    pos += length;
+                }
+                continue;
+            }
+            if (type == 'L' || type == 'K') {
+                std::string payload = readPayload(dataOffset, size);
+                payload.resize(strnlen(payload.c_str(), payload.size()));
+                (type == 'L' ? overridePath : overrideLink) = payload;
+                continue;
+            }
+            if (type == 'g') continue;
+
+            std::string name = fieldString(header.name, sizeof(header.name));
+            if (std::memcmp(header.magic, "ustar", 5) == 0 && header.prefix[0] != '\0') {
+                name = fieldString(header.prefix, sizeof(header.prefix)) + "/" + name;
+            }
+            std::string linkName = fieldString(header.linkname, sizeof(header.linkname));
+            if (overridePath) name = *overridePath;
+            if (overrideLink) linkName = *overrideLink;
+            overridePath.reset();
+            overrideLink.reset();
+            overrideSize.reset();
+
+            auto parts = sanitizeMemberName(name);
+            if (!parts) {
+                onWarning("unpack: skipping unsafe member name '" + name + "'");
+                ++stats.skipped;
+                continue;
+            }
+
+            // Ownership is not restored, so setuid/setgid/sticky bits are dropped;
+            // otherwise a root unpack would mint setuid-root binaries.
+            auto mode = static_cast<mode_t>(parseNumber(header.mode, sizeof(header.mode)) & 0777);
+            const std::string& leaf = parts->back();
+
+            if (type == '5') {
+                int dir = openParentDirectory(root, *parts, parts->size());
+                if (dir < 0) {
+                    onWarning(errnoMessage("unpack: cannot create directory", name));
+                    ++stats.skipped;
+                    continue;
+                }
+                ::fchmod(dir, mode | 0700);
+                ::close(dir);
+                ++stats.entries;
+                onEntry(name);
+                continue;
+            }
+
+            if (type != '0' && type != '\0' && type != '7' && type != '2' && type != '1') {
+                onWarning("unpack: skipping unsupported member '" + name + "'");
+                ++stats.skipped;
+                continue;
+            }
+
+            std::optional<std::vector<std::string>> linkTarget;
+            if (type == '1') {
+                linkTarget = sanitizeMemberName(linkName);
+                if (!linkTarget) {
+                    onWarning("unpack: skipping hard link '" + name + "' with unsafe target '" + linkName + "'");
+                    ++stats.skipped;
+                    continue;
+                }
+            }
+
+            int parent = openParentDirectory(root, *parts, parts->size() - 1);
+            if (parent < 0) {
+                onWarning(errnoMessage("unpack: cannot create parent of", name));
+                ++stats.skipped;
+                continue;
+            }
+            if (::unlinkat(parent, leaf.c_str(), 0) < 0 && errno != ENOENT) {
+                onWarning(errnoMessage("unpack: cannot replace", name));
+                ::close(parent);
+                ++stats.skipped;
+                continue;
+            }
+
+            bool ok = true;
+            if (type == '2') {
+                ok = ::symlinkat(linkName.c_str(), parent, leaf.c_str()) == 0;
+            } else if (type == '1') {
+                int targetParent = openParentDirectory(root, *linkTarget, linkTarget->size() - 1);
+                ok = targetParent >= 0 && ::linkat(targetParent, linkTarget->back().c_str(), parent, leaf.c_str(), 0) == 0;
+                if (targetParent >= 0) ::close(targetParent);
+            } else {
+                int fd = ::openat(parent, leaf.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, mode);
+                ok = fd >= 0;
+                if (ok && size > 0) {
+                    if (::fallocate(fd, 0, 0, static_cast<off_t>(size)) < 0 && errno != EOPNOTSUPP && errno != ENOSYS) {
+                        int savedErrno = errno;
+                        ::close(fd);
+                        ::unlinkat(parent, leaf.c_str(), 0);
+                        errno = savedErrno;
+                        ok = false;
+                    }
+                }
+                int jobParent = ok ? ::dup(parent) : -1;
+                if (ok && jobParent < 0) {
+                    int savedErrno = errno;
+                    ::close(fd);
+                    ::unlinkat(parent, leaf.c_str(), 0);
+                    errno = savedErrno;
+                    ok = false;
+                }
+                if (ok) {
+                    UnpackJob job{name, leaf, jobParent, fd, dataOffset, size, {}};
+                    job.times[0].tv_nsec = UTIME_OMIT;
+                    job.times[1].tv_sec = static_cast<time_t>(parseNumber(header.mtime, sizeof(header.mtime)));
+
+                    std::unique_lock lock(mutex);
+                    changed.wait(lock, [&] { return jobs.size() < kWindowSize; });
+                    jobs.push_back(std::move(job));
+                    changed.notify_all();
+                    stats.bytes += size;
+                }
+            }
+
+            if (!ok) {
+                onWarning(errnoMessage("unpack: cannot create", name));
+                ++stats.skipped;
+            } else {
+                ++stats.entries;
+                onEntry(name);
+            }
+            ::close(parent);
+        }
+    } catch (...) {
+        shutdown();
+        throw;
+    }
+
+    shutdown();
+    for (const auto& failure : failures) {
+        onWarning(failure);
+        ++stats.skipped;
+    }
+    return stats;
+}
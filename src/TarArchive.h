@@ -0,0 +1,38 @@
+#ifndef TARARCHIVE_H
+#define TARARCHIVE_H
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <filesystem>
+#include <cstdint>
+
+namespace fs = std::filesystem;
+
+using ArchiveLogger = std::function<void(const std::string&)>;
+
+struct ArchiveStats {
+    std::uintmax_t entries = 0;
+    std::uintmax_t bytes = 0;
+    std::uintmax_t skipped = 0;
+};
+
+// Streaming POSIX ustar/pax archiver. Both directions keep only a fixed
+// window of entries in flight, so memory use does not grow with the archive.
+class TarArchive {
+public:
+    // Writes PATHs (recursively, relative to `base`) to `archive`. Files are opened
+    // and prefetched by a pool of readers while a single writer emits them in walk order.
+    static ArchiveStats pack(const fs::path& archive, const fs::path& base, const std::vector<std::string>& paths,
+                             const ArchiveLogger& onEntry, const ArchiveLogger& onWarning);
+
+    // Extracts `archive` below `destination`. Headers are read sequentially,
+    // file contents are copied by a pool of writers into preallocated files.
+    static ArchiveStats unpack(const fs::path& archive, const fs::path& destination,
+                               const ArchiveLogger& onEntry, const ArchiveLogger& onWarning);
+
+private:
+    static unsigned workerCount();
+};
+
+#endif